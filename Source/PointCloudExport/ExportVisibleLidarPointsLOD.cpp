@@ -12,6 +12,13 @@
 #include "Misc/Paths.h"
 #include "EngineUtils.h"
 #include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Sort.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryWriter.h"
+#include "Templates/UniquePtr.h"
+#include <cmath>
 #if WITH_EDITOR
 #include "AssetRegistry/AssetRegistryModule.h"
 #include "UObject/Package.h"
@@ -83,60 +90,56 @@ static void BuildFrustumFromCamera(const UCameraComponent* Camera, FConvexVolume
 }
 
 
-
 // ------------------------------------------------------------
-//  メイン関数: 点群エクスポート
+//  ヘルパ: LOD パラメータの検証
 // ------------------------------------------------------------
-bool UExportVisibleLidarPointsLOD::ExportVisiblePointsLOD(
-    const TArray<ALidarPointCloudActor*>& PointCloudActors,
-    UCameraComponent* Camera,
-    const FString& AbsoluteFilePath,
-    float FrustumFar,
-    float NearFullResRadius,
-    float MidSkipRadius,
-    float FarSkipRadius,
-    int32 SkipFactorMid,
-    int32 SkipFactorFar,
-    bool bWorldSpace,
-    bool bExportTexture,
-    int32 MaxPointCount)
+static bool ValidateLODSettings(const TCHAR* Caller,
+    float NearFullResRadius, float MidSkipRadius, float FarSkipRadius,
+    int32 SkipFactorMid, int32 SkipFactorFar)
 {
-    if (PointCloudActors.Num() == 0 || !Camera)
-    {
-        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsLOD: Invalid input."));
-        return false;
-    }
-
-    if (AbsoluteFilePath.IsEmpty())
-    {
-        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsLOD: AbsoluteFilePath is empty."));
-        return false;
-    }
     if (NearFullResRadius <= 0.f || MidSkipRadius <= 0.f || FarSkipRadius <= 0.f)
     {
-        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsLOD: Radius values must be > 0."));
+        UE_LOG(LogTemp, Warning, TEXT("%s: Radius values must be > 0."), Caller);
         return false;
     }
     if (!(NearFullResRadius < MidSkipRadius && MidSkipRadius < FarSkipRadius))
     {
-        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsLOD: Radius values are inconsistent."));
+        UE_LOG(LogTemp, Warning, TEXT("%s: Radius values are inconsistent."), Caller);
         return false;
     }
     if (SkipFactorMid < 1 || SkipFactorFar < 1)
     {
-        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsLOD: Skip factors must be >= 1."));
+        UE_LOG(LogTemp, Warning, TEXT("%s: Skip factors must be >= 1."), Caller);
         return false;
     }
     if (SkipFactorFar < SkipFactorMid)
     {
-        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsLOD: SkipFactorFar should be >= SkipFactorMid."));
+        UE_LOG(LogTemp, Warning, TEXT("%s: SkipFactorFar should be >= SkipFactorMid."), Caller);
         return false;
     }
+    return true;
+}
 
-    // 1) 視錐台フィルタリング
-    FConvexVolume WorldFrustum;
-    BuildFrustumFromCamera(Camera, WorldFrustum, FrustumFar);
+// ------------------------------------------------------------
+//  ヘルパ: 出力先ディレクトリを作成
+// ------------------------------------------------------------
+static bool EnsureOutputDirectory(const TCHAR* Caller, const FString& AbsoluteFilePath)
+{
+    const FString DirectoryPath = FPaths::GetPath(AbsoluteFilePath);
+    if (!DirectoryPath.IsEmpty() && !IFileManager::Get().DirectoryExists(*DirectoryPath))
+    {
+        if (!IFileManager::Get().MakeDirectory(*DirectoryPath, true))
+        {
+            UE_LOG(LogTemp, Error,
+                TEXT("%s: Failed to create directory %s"), Caller, *DirectoryPath);
+            return false;
+        }
+    }
+    return true;
+}
 
+namespace
+{
     struct FPointRec
     {
         FVector WorldPos;
@@ -144,11 +147,25 @@ bool UExportVisibleLidarPointsLOD::ExportVisiblePointsLOD(
         // Color.A stores the intensity value from the source point cloud
         FColor   Color;
     };
+}
 
-    TArray<FPointRec> AllPoints;
-    ULidarPointCloud* FirstCloud = nullptr;
-
-    const bool bUseLimit = MaxPointCount > 0;
+// ------------------------------------------------------------
+//  ヘルパ: 視錐台内の点を距離 LOD で間引いて収集
+// ------------------------------------------------------------
+static void GatherVisiblePoints(
+    const TArray<ALidarPointCloudActor*>& PointCloudActors,
+    const UCameraComponent* Camera,
+    float FrustumFar,
+    float NearFullResRadius,
+    float MidSkipRadius,
+    float FarSkipRadius,
+    int32 SkipFactorMid,
+    int32 SkipFactorFar,
+    TArray<FPointRec>& OutPoints,
+    ULidarPointCloud*& OutFirstCloud)
+{
+    FConvexVolume WorldFrustum;
+    BuildFrustumFromCamera(Camera, WorldFrustum, FrustumFar);
 
     const FVector CamLoc = Camera->GetComponentLocation();
 
@@ -219,18 +236,62 @@ bool UExportVisibleLidarPointsLOD::ExportVisiblePointsLOD(
 
         ULidarPointCloudComponent* CompCheck = Actor->GetPointCloudComponent();
         ULidarPointCloud* CloudCheck = CompCheck ? CompCheck->GetPointCloud() : nullptr;
-        if (!FirstCloud && CloudCheck)
+        if (!OutFirstCloud && CloudCheck)
         {
-            FirstCloud = CloudCheck;
+            OutFirstCloud = CloudCheck;
         }
     }
 
     for (TFuture<TArray<FPointRec>>& Future : Futures)
     {
         TArray<FPointRec> Points = Future.Get();
-        AllPoints.Append(MoveTemp(Points));
+        OutPoints.Append(MoveTemp(Points));
+    }
+}
+
+// ------------------------------------------------------------
+//  メイン関数: 点群エクスポート
+// ------------------------------------------------------------
+bool UExportVisibleLidarPointsLOD::ExportVisiblePointsLOD(
+    const TArray<ALidarPointCloudActor*>& PointCloudActors,
+    UCameraComponent* Camera,
+    const FString& AbsoluteFilePath,
+    float FrustumFar,
+    float NearFullResRadius,
+    float MidSkipRadius,
+    float FarSkipRadius,
+    int32 SkipFactorMid,
+    int32 SkipFactorFar,
+    bool bWorldSpace,
+    bool bExportTexture,
+    int32 MaxPointCount)
+{
+    if (PointCloudActors.Num() == 0 || !Camera)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsLOD: Invalid input."));
+        return false;
+    }
+
+    if (AbsoluteFilePath.IsEmpty())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsLOD: AbsoluteFilePath is empty."));
+        return false;
+    }
+    if (!ValidateLODSettings(TEXT("ExportVisiblePointsLOD"),
+        NearFullResRadius, MidSkipRadius, FarSkipRadius, SkipFactorMid, SkipFactorFar))
+    {
+        return false;
     }
 
+    // 1) 視錐台フィルタリング
+    TArray<FPointRec> AllPoints;
+    ULidarPointCloud* FirstCloud = nullptr;
+    GatherVisiblePoints(PointCloudActors, Camera, FrustumFar,
+        NearFullResRadius, MidSkipRadius, FarSkipRadius, SkipFactorMid, SkipFactorFar,
+        AllPoints, FirstCloud);
+
+    const bool bUseLimit = MaxPointCount > 0;
+
     if (AllPoints.Num() == 0)
     {
         UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsLOD: No points in frustum."));
@@ -294,15 +355,9 @@ bool UExportVisibleLidarPointsLOD::ExportVisiblePointsLOD(
         return false;
     }
 
-    const FString DirectoryPath = FPaths::GetPath(AbsoluteFilePath);
-    if (!DirectoryPath.IsEmpty() && !IFileManager::Get().DirectoryExists(*DirectoryPath))
+    if (!EnsureOutputDirectory(TEXT("ExportVisiblePointsLOD"), AbsoluteFilePath))
     {
-        if (!IFileManager::Get().MakeDirectory(*DirectoryPath, true))
-        {
-            UE_LOG(LogTemp, Error,
-                TEXT("ExportVisiblePointsLOD: Failed to create directory %s"), *DirectoryPath);
-            return false;
-        }
+        return false;
     }
 
     const FString Joined = FString::Join(Lines, TEXT("\n")) + TEXT("\n");
@@ -369,6 +424,582 @@ bool UExportVisibleLidarPointsLOD::ExportVisiblePointsLOD(
     return true;
 }
 
+// ------------------------------------------------------------
+//  圧縮バイナリ (.pcxb) フォーマット
+//
+//  [Header][BlockEntry x BlockCount][Block 0][Block 1]...
+//  ブロックは FCompression で個別に圧縮され、展開後は次の並び:
+//    varint x N : ブロック内量子化座標のモートン符号 (昇順) の差分
+//    uint8  x N : R / G / B / Intensity の各プレーン
+//  位置 = BoundsMin + 量子化座標 * Step  [m]
+// ------------------------------------------------------------
+namespace PointCloudBlockFormat
+{
+    static constexpr uint32 Magic = 0x42584350; // "PCXB"
+    static constexpr uint32 Version = 2;
+    static constexpr int32 MinPointsPerBlock = 256;
+    static constexpr int32 MaxPointsPerBlock = 1 << 20;
+    // 1 軸 21bit → 63bit のモートン符号
+    static constexpr uint32 MaxGridCoord = (1u << 21) - 1;
+    // FBlockEntry のシリアライズ後のサイズ [byte]
+    static constexpr int64 BlockEntrySize = 72;
+    // varint (63bit で最大 9 byte) + RGBA 4 byte
+    static constexpr int64 MaxRawBytesPerPoint = 13;
+
+    struct FHeader
+    {
+        uint32 Magic = 0;
+        uint32 Version = 0;
+        uint8  Codec = 0;
+        uint8  bWorldSpace = 0;
+        uint32 PointsPerBlock = 0;
+        uint32 BlockCount = 0;
+        uint64 PointCount = 0;
+
+        friend FArchive& operator<<(FArchive& Ar, FHeader& H)
+        {
+            return Ar << H.Magic << H.Version << H.Codec << H.bWorldSpace
+                << H.PointsPerBlock << H.BlockCount << H.PointCount;
+        }
+    };
+
+    struct FBlockEntry
+    {
+        FVector3d BoundsMin = FVector3d::ZeroVector;
+        FVector3d BoundsMax = FVector3d::ZeroVector;
+        float  Step = 0.f;
+        uint32 PointCount = 0;
+        uint64 Offset = 0;
+        uint32 CompressedSize = 0;
+        uint32 RawSize = 0;
+
+        friend FArchive& operator<<(FArchive& Ar, FBlockEntry& E)
+        {
+            return Ar << E.BoundsMin << E.BoundsMax << E.Step << E.PointCount
+                << E.Offset << E.CompressedSize << E.RawSize;
+        }
+    };
+
+    static FName GetFormatName(ELidarExportCompression Codec)
+    {
+        switch (Codec)
+        {
+        case ELidarExportCompression::Zlib: return NAME_Zlib;
+        case ELidarExportCompression::LZ4:  return NAME_LZ4;
+        default:                            return NAME_Oodle;
+        }
+    }
+
+    static uint64 SplitBy3(uint32 V)
+    {
+        uint64 X = V & MaxGridCoord;
+        X = (X | X << 32) & 0x001f00000000ffffull;
+        X = (X | X << 16) & 0x001f0000ff0000ffull;
+        X = (X | X << 8)  & 0x100f00f00f00f00full;
+        X = (X | X << 4)  & 0x10c30c30c30c30c3ull;
+        X = (X | X << 2)  & 0x1249249249249249ull;
+        return X;
+    }
+
+    static uint32 CompactBy3(uint64 X)
+    {
+        X &= 0x1249249249249249ull;
+        X = (X ^ (X >> 2))  & 0x10c30c30c30c30c3ull;
+        X = (X ^ (X >> 4))  & 0x100f00f00f00f00full;
+        X = (X ^ (X >> 8))  & 0x001f0000ff0000ffull;
+        X = (X ^ (X >> 16)) & 0x001f00000000ffffull;
+        X = (X ^ (X >> 32)) & MaxGridCoord;
+        return (uint32)X;
+    }
+
+    static uint64 EncodeMorton(uint32 X, uint32 Y, uint32 Z)
+    {
+        return SplitBy3(X) | (SplitBy3(Y) << 1) | (SplitBy3(Z) << 2);
+    }
+
+    // float へ丸めたときに V 以上になる値を返す
+    static float RoundUpToFloat(double V)
+    {
+        const float F = (float)V;
+        return (double)F < V ? std::nextafter(F, TNumericLimits<float>::Max()) : F;
+    }
+
+    static uint32 Quantize(double V, double Min, double InvStep)
+    {
+        const double Q = FMath::RoundToDouble((V - Min) * InvStep);
+        return (uint32)FMath::Clamp(Q, 0.0, (double)MaxGridCoord);
+    }
+
+    static void WriteVarint(TArray<uint8>& Out, uint64 V)
+    {
+        while (V >= 0x80)
+        {
+            Out.Add((uint8)(V | 0x80));
+            V >>= 7;
+        }
+        Out.Add((uint8)V);
+    }
+
+    static bool ReadVarint(const uint8* Data, int32 Size, int32& Pos, uint64& OutV)
+    {
+        OutV = 0;
+        for (int32 Shift = 0; Shift < 64 && Pos < Size; Shift += 7)
+        {
+            const uint8 Byte = Data[Pos++];
+            OutV |= (uint64)(Byte & 0x7f) << Shift;
+            if ((Byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** 1 ブロック分の点を量子化して非圧縮のブロックデータを作る */
+    static void EncodeBlock(
+        const TArray<FVector>& Positions,
+        const TArray<FColor>& Colors,
+        const TArray<int32>& Order,
+        int32 First,
+        int32 Count,
+        double QuantizationStep,
+        TArray<uint8>& OutRaw,
+        FBlockEntry& OutEntry)
+    {
+        FVector Min(TNumericLimits<double>::Max());
+        FVector Max(TNumericLimits<double>::Lowest());
+        for (int32 i = First; i < First + Count; ++i)
+        {
+            Min = Min.ComponentMin(Positions[Order[i]]);
+            Max = Max.ComponentMax(Positions[Order[i]]);
+        }
+        // 原点は double のまま保存し (全点のオフセットが 0 以上)、ステップはファイルと同じ float で量子化する
+        const FVector Origin = Min;
+        const float StepF = RoundUpToFloat(FMath::Max(QuantizationStep, (Max - Origin).GetMax() / (double)MaxGridCoord));
+        const double Step = StepF;
+        const double InvStep = 1.0 / Step;
+
+        TArray<TPair<uint64, int32>> Codes;
+        Codes.SetNumUninitialized(Count);
+        uint32 QMax[3] = { 0, 0, 0 };
+        for (int32 i = 0; i < Count; ++i)
+        {
+            const int32 Src = Order[First + i];
+            const FVector& P = Positions[Src];
+            const uint32 QX = Quantize(P.X, Origin.X, InvStep);
+            const uint32 QY = Quantize(P.Y, Origin.Y, InvStep);
+            const uint32 QZ = Quantize(P.Z, Origin.Z, InvStep);
+            QMax[0] = FMath::Max(QMax[0], QX);
+            QMax[1] = FMath::Max(QMax[1], QY);
+            QMax[2] = FMath::Max(QMax[2], QZ);
+            Codes[i] = TPair<uint64, int32>(EncodeMorton(QX, QY, QZ), Src);
+        }
+        Algo::SortBy(Codes, [](const TPair<uint64, int32>& C) { return C.Key; });
+
+        OutRaw.Reset(Count * 8);
+        uint64 Prev = 0;
+        for (const TPair<uint64, int32>& C : Codes)
+        {
+            WriteVarint(OutRaw, C.Key - Prev);
+            Prev = C.Key;
+        }
+        const int32 PlaneStart = OutRaw.Num();
+        OutRaw.AddUninitialized(Count * 4);
+        uint8* Planes = OutRaw.GetData() + PlaneStart;
+        for (int32 i = 0; i < Count; ++i)
+        {
+            const FColor& C = Colors[Codes[i].Value];
+            Planes[i] = C.R;
+            Planes[Count + i] = C.G;
+            Planes[Count * 2 + i] = C.B;
+            Planes[Count * 3 + i] = C.A;
+        }
+
+        // DecodeBlock と同じ式で最大点を復元するので、復元した点は必ず範囲内に収まる
+        OutEntry.BoundsMin = Origin;
+        OutEntry.BoundsMax = Origin + FVector((double)QMax[0], (double)QMax[1], (double)QMax[2]) * Step;
+        OutEntry.Step = StepF;
+        OutEntry.PointCount = (uint32)Count;
+        OutEntry.RawSize = (uint32)OutRaw.Num();
+    }
+
+    /** 展開済みブロックから QueryBox 内の点を取り出す (QueryBox が無効なら全点) */
+    static bool DecodeBlock(
+        const TArray<uint8>& Raw,
+        const FBlockEntry& Entry,
+        const FBox& QueryBox,
+        TArray<FVector>& OutPositions,
+        TArray<FColor>& OutColors)
+    {
+        const int32 Count = (int32)Entry.PointCount;
+        const int32 PlaneStart = Raw.Num() - Count * 4;
+        if (PlaneStart < 0)
+        {
+            return false;
+        }
+        const uint8* Data = Raw.GetData();
+        const uint8* Planes = Data + PlaneStart;
+        const FVector Origin(Entry.BoundsMin);
+        const double Step = Entry.Step;
+
+        OutPositions.Reserve(Count);
+        OutColors.Reserve(Count);
+        int32 Pos = 0;
+        uint64 Code = 0;
+        for (int32 i = 0; i < Count; ++i)
+        {
+            uint64 Delta = 0;
+            if (!ReadVarint(Data, PlaneStart, Pos, Delta))
+            {
+                return false;
+            }
+            Code += Delta;
+            const FVector P = Origin + FVector(
+                (double)CompactBy3(Code), (double)CompactBy3(Code >> 1), (double)CompactBy3(Code >> 2)) * Step;
+            if (QueryBox.IsValid && !QueryBox.IsInsideOrOn(P))
+            {
+                continue;
+            }
+            OutPositions.Add(P);
+            OutColors.Add(FColor(Planes[i], Planes[Count + i], Planes[Count * 2 + i], Planes[Count * 3 + i]));
+        }
+        return Pos == PlaneStart;
+    }
+}
+
+// ------------------------------------------------------------
+//  圧縮バイナリエクスポート
+// ------------------------------------------------------------
+bool UExportVisibleLidarPointsLOD::ExportVisiblePointsCompressed(
+    const TArray<ALidarPointCloudActor*>& PointCloudActors,
+    UCameraComponent* Camera,
+    const FString& AbsoluteFilePath,
+    ELidarExportCompression Compression,
+    int32 PointsPerBlock,
+    float QuantizationStep,
+    float FrustumFar,
+    float NearFullResRadius,
+    float MidSkipRadius,
+    float FarSkipRadius,
+    int32 SkipFactorMid,
+    int32 SkipFactorFar,
+    bool bWorldSpace,
+    int32 MaxPointCount)
+{
+    using namespace PointCloudBlockFormat;
+
+    if (PointCloudActors.Num() == 0 || !Camera)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsCompressed: Invalid input."));
+        return false;
+    }
+    if (AbsoluteFilePath.IsEmpty())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsCompressed: AbsoluteFilePath is empty."));
+        return false;
+    }
+    if (QuantizationStep <= 0.f)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsCompressed: QuantizationStep must be > 0."));
+        return false;
+    }
+    if (!ValidateLODSettings(TEXT("ExportVisiblePointsCompressed"),
+        NearFullResRadius, MidSkipRadius, FarSkipRadius, SkipFactorMid, SkipFactorFar))
+    {
+        return false;
+    }
+
+    TArray<FPointRec> AllPoints;
+    ULidarPointCloud* FirstCloud = nullptr;
+    GatherVisiblePoints(PointCloudActors, Camera, FrustumFar,
+        NearFullResRadius, MidSkipRadius, FarSkipRadius, SkipFactorMid, SkipFactorFar,
+        AllPoints, FirstCloud);
+
+    if (MaxPointCount > 0 && AllPoints.Num() > MaxPointCount)
+    {
+        AllPoints.SetNum(MaxPointCount);
+    }
+    if (AllPoints.Num() == 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ExportVisiblePointsCompressed: No points in frustum."));
+        return false;
+    }
+
+    const int32 PointCount = AllPoints.Num();
+    const int32 BlockSize = FMath::Clamp(PointsPerBlock, MinPointsPerBlock, MaxPointsPerBlock);
+    const int32 BlockCount = FMath::DivideAndRoundUp(PointCount, BlockSize);
+    const FName FormatName = GetFormatName(Compression);
+
+    const double EncodeStart = FPlatformTime::Seconds();
+
+    // テキスト出力と同じ座標系 (m, Y 反転) に変換
+    TArray<FVector> Positions;
+    TArray<FColor> Colors;
+    Positions.SetNumUninitialized(PointCount);
+    Colors.SetNumUninitialized(PointCount);
+    ParallelFor(PointCount, [&](int32 i)
+    {
+        const FVector& UsePos = bWorldSpace ? AllPoints[i].WorldPos : AllPoints[i].LocalPos;
+        Positions[i] = FVector(UsePos.X * 0.01, -UsePos.Y * 0.01, UsePos.Z * 0.01);
+        Colors[i] = AllPoints[i].Color;
+    });
+    AllPoints.Empty();
+
+    // 全体をモートン順に並べ、空間的にまとまったブロックに分割する
+    FBox Bounds(Positions.GetData(), PointCount);
+    const double GlobalInvStep = (double)MaxGridCoord / FMath::Max(Bounds.GetSize().GetMax(), UE_DOUBLE_SMALL_NUMBER);
+    TArray<uint64> GlobalCodes;
+    GlobalCodes.SetNumUninitialized(PointCount);
+    ParallelFor(PointCount, [&](int32 i)
+    {
+        const FVector& P = Positions[i];
+        GlobalCodes[i] = EncodeMorton(
+            Quantize(P.X, Bounds.Min.X, GlobalInvStep),
+            Quantize(P.Y, Bounds.Min.Y, GlobalInvStep),
+            Quantize(P.Z, Bounds.Min.Z, GlobalInvStep));
+    });
+    TArray<int32> Order;
+    Order.SetNumUninitialized(PointCount);
+    for (int32 i = 0; i < PointCount; ++i)
+    {
+        Order[i] = i;
+    }
+    Algo::SortBy(Order, [&GlobalCodes](int32 i) { return GlobalCodes[i]; });
+    GlobalCodes.Empty();
+
+    TArray<FBlockEntry> Index;
+    TArray<TArray<uint8>> Blocks;
+    Index.SetNum(BlockCount);
+    Blocks.SetNum(BlockCount);
+    ParallelFor(BlockCount, [&](int32 b)
+    {
+        const int32 First = b * BlockSize;
+        const int32 Count = FMath::Min(BlockSize, PointCount - First);
+        TArray<uint8> Raw;
+        EncodeBlock(Positions, Colors, Order, First, Count, QuantizationStep, Raw, Index[b]);
+
+        int32 CompressedSize = FCompression::CompressMemoryBound(FormatName, Raw.Num());
+        Blocks[b].SetNumUninitialized(CompressedSize);
+        if (FCompression::CompressMemory(FormatName, Blocks[b].GetData(), CompressedSize, Raw.GetData(), Raw.Num()))
+        {
+            Blocks[b].SetNum(CompressedSize);
+        }
+        else
+        {
+            Blocks[b].Reset();
+        }
+        Index[b].CompressedSize = (uint32)Blocks[b].Num();
+    });
+
+    const double EncodeSeconds = FPlatformTime::Seconds() - EncodeStart;
+
+    int64 RawBytes = 0;
+    for (int32 b = 0; b < BlockCount; ++b)
+    {
+        if (Blocks[b].Num() == 0)
+        {
+            UE_LOG(LogTemp, Error,
+                TEXT("ExportVisiblePointsCompressed: Failed to compress block %d with %s"), b, *FormatName.ToString());
+            return false;
+        }
+        RawBytes += Index[b].RawSize;
+    }
+
+    FHeader Header;
+    Header.Magic = Magic;
+    Header.Version = Version;
+    Header.Codec = (uint8)Compression;
+    Header.bWorldSpace = bWorldSpace ? 1 : 0;
+    Header.PointsPerBlock = (uint32)BlockSize;
+    Header.BlockCount = (uint32)BlockCount;
+    Header.PointCount = (uint64)PointCount;
+
+    TArray<uint8> FileData;
+    FMemoryWriter Writer(FileData);
+    Writer << Header;
+    const int64 IndexStart = Writer.Tell();
+    for (FBlockEntry& Entry : Index)
+    {
+        Writer << Entry;
+    }
+    uint64 Offset = (uint64)Writer.Tell();
+    for (int32 b = 0; b < BlockCount; ++b)
+    {
+        Index[b].Offset = Offset;
+        Offset += Index[b].CompressedSize;
+    }
+    Writer.Seek(IndexStart);
+    for (FBlockEntry& Entry : Index)
+    {
+        Writer << Entry;
+    }
+    Writer.Seek(FileData.Num());
+    for (TArray<uint8>& Block : Blocks)
+    {
+        Writer.Serialize(Block.GetData(), Block.Num());
+    }
+
+    if (!EnsureOutputDirectory(TEXT("ExportVisiblePointsCompressed"), AbsoluteFilePath))
+    {
+        return false;
+    }
+    if (!FFileHelper::SaveArrayToFile(FileData, *AbsoluteFilePath, &IFileManager::Get(), FILEWRITE_AllowRead))
+    {
+        UE_LOG(LogTemp, Error,
+            TEXT("ExportVisiblePointsCompressed: Failed to save file %s"), *AbsoluteFilePath);
+        return false;
+    }
+
+    const double SafeSeconds = FMath::Max(EncodeSeconds, UE_DOUBLE_SMALL_NUMBER);
+    UE_LOG(LogTemp, Log,
+        TEXT("ExportVisiblePointsCompressed: Wrote %d points in %d blocks (%s) → %s, %lld → %d bytes (%.2fx), encode %.3f s, %.1f MB/s, %.2f Mpts/s"),
+        PointCount, BlockCount, *FormatName.ToString(), *AbsoluteFilePath,
+        RawBytes, FileData.Num(), (double)RawBytes / FMath::Max(FileData.Num(), 1),
+        EncodeSeconds, RawBytes / SafeSeconds / (1024.0 * 1024.0), PointCount / SafeSeconds / 1.0e6);
+    return true;
+}
+
+// ------------------------------------------------------------
+//  圧縮バイナリから範囲内の点を読み出す
+// ------------------------------------------------------------
+bool UExportVisibleLidarPointsLOD::ReadCompressedPointsInBox(
+    const FString& AbsoluteFilePath,
+    const FBox& QueryBox,
+    TArray<FVector>& OutPositions,
+    TArray<FColor>& OutColors)
+{
+    using namespace PointCloudBlockFormat;
+
+    OutPositions.Reset();
+    OutColors.Reset();
+
+    TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*AbsoluteFilePath));
+    if (!Reader)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ReadCompressedPointsInBox: Failed to open %s"), *AbsoluteFilePath);
+        return false;
+    }
+
+    FHeader Header;
+    *Reader << Header;
+    if (Reader->IsError() || Header.Magic != Magic || Header.Version != Version
+        || Header.Codec > (uint8)ELidarExportCompression::LZ4
+        || Header.PointsPerBlock == 0 || Header.PointsPerBlock > (uint32)MaxPointsPerBlock)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ReadCompressedPointsInBox: %s is not a valid point block file."), *AbsoluteFilePath);
+        return false;
+    }
+    const FName FormatName = GetFormatName((ELidarExportCompression)Header.Codec);
+
+    // インデックスの値はファイル由来なので、確保やオフセット計算に使う前に検証する
+    const int64 FileSize = Reader->TotalSize();
+    TArray<FBlockEntry> Index;
+    bool bIndexValid = (int64)Header.BlockCount * BlockEntrySize <= FileSize - Reader->Tell();
+    if (bIndexValid)
+    {
+        Index.SetNum(Header.BlockCount);
+        for (FBlockEntry& Entry : Index)
+        {
+            *Reader << Entry;
+            const uint64 MinRaw = (uint64)Entry.PointCount * 4;
+            const uint64 MaxRaw = (uint64)Entry.PointCount * MaxRawBytesPerPoint;
+            if (Reader->IsError()
+                || Entry.PointCount > Header.PointsPerBlock
+                || Entry.RawSize < MinRaw || Entry.RawSize > MaxRaw
+                || Entry.CompressedSize > (uint32)MAX_int32
+                || Entry.Offset > (uint64)FileSize
+                || Entry.CompressedSize > (uint64)FileSize - Entry.Offset)
+            {
+                bIndexValid = false;
+                break;
+            }
+        }
+    }
+    if (!bIndexValid)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ReadCompressedPointsInBox: Corrupt block index in %s"), *AbsoluteFilePath);
+        return false;
+    }
+
+    // 範囲と交差するブロックだけを読み込む
+    TArray<int32> Selected;
+    TArray<TArray<uint8>> Compressed;
+    for (int32 b = 0; b < Index.Num() && !Reader->IsError(); ++b)
+    {
+        const FBlockEntry& Entry = Index[b];
+        const FBox BlockBox(Entry.BoundsMin, Entry.BoundsMax);
+        if (QueryBox.IsValid && !QueryBox.Intersect(BlockBox))
+        {
+            continue;
+        }
+        Selected.Add(b);
+        TArray<uint8>& Data = Compressed.AddDefaulted_GetRef();
+        Data.SetNumUninitialized(Entry.CompressedSize);
+        Reader->Seek((int64)Entry.Offset);
+        Reader->Serialize(Data.GetData(), Data.Num());
+    }
+    if (Reader->IsError())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ReadCompressedPointsInBox: Failed to read blocks from %s"), *AbsoluteFilePath);
+        return false;
+    }
+    Reader.Reset();
+
+    const double DecodeStart = FPlatformTime::Seconds();
+
+    TArray<TArray<FVector>> BlockPositions;
+    TArray<TArray<FColor>> BlockColors;
+    TArray<bool> BlockOk;
+    BlockPositions.SetNum(Selected.Num());
+    BlockColors.SetNum(Selected.Num());
+    BlockOk.Init(false, Selected.Num());
+    ParallelFor(Selected.Num(), [&](int32 i)
+    {
+        const FBlockEntry& Entry = Index[Selected[i]];
+        TArray<uint8> Raw;
+        Raw.SetNumUninitialized(Entry.RawSize);
+        if (!FCompression::UncompressMemory(FormatName, Raw.GetData(), Raw.Num(),
+            Compressed[i].GetData(), Compressed[i].Num()))
+        {
+            return;
+        }
+        BlockOk[i] = DecodeBlock(Raw, Entry, QueryBox, BlockPositions[i], BlockColors[i]);
+    });
+
+    const double DecodeSeconds = FPlatformTime::Seconds() - DecodeStart;
+
+    int64 RawBytes = 0;
+    int64 DecodedPoints = 0;
+    int32 ResultCount = 0;
+    for (int32 i = 0; i < Selected.Num(); ++i)
+    {
+        if (!BlockOk[i])
+        {
+            UE_LOG(LogTemp, Warning,
+                TEXT("ReadCompressedPointsInBox: Failed to decode block %d in %s"), Selected[i], *AbsoluteFilePath);
+            return false;
+        }
+        RawBytes += Index[Selected[i]].RawSize;
+        DecodedPoints += Index[Selected[i]].PointCount;
+        ResultCount += BlockPositions[i].Num();
+    }
+
+    OutPositions.Reserve(ResultCount);
+    OutColors.Reserve(ResultCount);
+    for (int32 i = 0; i < Selected.Num(); ++i)
+    {
+        OutPositions.Append(MoveTemp(BlockPositions[i]));
+        OutColors.Append(MoveTemp(BlockColors[i]));
+    }
+
+    const double SafeSeconds = FMath::Max(DecodeSeconds, UE_DOUBLE_SMALL_NUMBER);
+    UE_LOG(LogTemp, Log,
+        TEXT("ReadCompressedPointsInBox: Decoded %d/%d blocks (%lld points) → %d points in box, decode %.3f s, %.1f MB/s, %.2f Mpts/s"),
+        Selected.Num(), Index.Num(), DecodedPoints, ResultCount,
+        DecodeSeconds, RawBytes / SafeSeconds / (1024.0 * 1024.0), DecodedPoints / SafeSeconds / 1.0e6);
+    return true;
+}
+
 // ------------------------------------------------------------
 //  指定カメラから見える LidarPointCloudActor を取得
 // ------------------------------------------------------------
@@ -7,6 +7,15 @@
 
 class UCameraComponent;
 
+/** 圧縮バイナリ出力で使用する FCompression コーデック */
+UENUM(BlueprintType)
+enum class ELidarExportCompression : uint8
+{
+    Oodle,
+    Zlib,
+    LZ4
+};
+
 /**
  *
  * 生成されるファイル: 1 行 1 点の ASCII
@@ -52,6 +61,67 @@ public:
         int32                  MaxPointCount = 20000000
       );
 
+    /**
+     * ExportVisiblePointsLOD と同じ LOD 処理を行い、圧縮バイナリ (.pcxb) として保存
+     *
+     * 点はモートン順に並べ替えて PointsPerBlock 点ごとのブロックに分割する。
+     * 各ブロックは位置を量子化したモートン符号の差分 (varint) と R/G/B/Intensity の
+     * バイトプレーンに変換し、ブロック単位で並列に圧縮する。
+     * ファイル先頭のブロックインデックス (範囲 / オフセット) により任意領域だけを読み出せる。
+     * 座標系・単位はテキスト出力と同じ (m, Y 反転)。
+     *
+     * @param PointCloudActors    対象となる LidarPointCloudActor 配列
+     * @param Camera              参照するカメラコンポーネント
+     * @param AbsoluteFilePath    例: "C:/Temp/VisiblePoints.pcxb"
+     * @param Compression         ブロック圧縮に使うコーデック
+     * @param PointsPerBlock      1 ブロックあたりの点数 (256 ～ 1048576 に丸める)
+     * @param QuantizationStep    位置の量子化ステップ [m] (ブロックが大きい場合は自動で粗くなる)
+     * @param FrustumFar          視錐台の Far 値                  [cm]
+     * @param NearFullResRadius   この距離以内は全点保持         [cm]
+     * @param MidSkipRadius       この距離を超えると SkipFactorMid で間引く [cm]
+     * @param FarSkipRadius       この距離を超えると SkipFactorFar で間引く [cm]
+     * @param SkipFactorMid       上記距離帯でのサンプリング間隔 (2=1/2 点)
+     * @param SkipFactorFar       最遠距離帯でのサンプリング間隔
+     * @param bWorldSpace         true: ワールド座標 / false: 点群ローカル
+     * @param MaxPointCount       LOD 適用後に出力するポイント数の上限 (0 以下で無制限)
+     * @return                    成功可否
+     */
+    UFUNCTION(BlueprintCallable, Category = "Lidar|Export")
+    static bool ExportVisiblePointsCompressed(
+        const TArray<ALidarPointCloudActor*>& PointCloudActors,
+        UCameraComponent*      Camera,
+        const FString&         AbsoluteFilePath,
+        ELidarExportCompression Compression = ELidarExportCompression::Oodle,
+        int32                  PointsPerBlock = 65536,
+        float                  QuantizationStep = 0.001f,
+        float                  FrustumFar = 10000.f,
+        float                  NearFullResRadius = 5000.f,
+        float                  MidSkipRadius = 20000.f,
+        float                  FarSkipRadius = 100000.f,
+        int32                  SkipFactorMid = 2,
+        int32                  SkipFactorFar = 10,
+        bool                   bWorldSpace = true,
+        int32                  MaxPointCount = 20000000
+    );
+
+    /**
+     * ExportVisiblePointsCompressed で保存したファイルから、指定範囲の点だけを読み出す
+     * 範囲と交差するブロックのみを展開し、それ以外のブロックは読み込まない
+     *
+     * @param AbsoluteFilePath    読み込む .pcxb ファイル
+     * @param QueryBox            取得範囲 [m] (ファイルと同じ座標系、無効な Box なら全点)
+     * @param OutPositions        範囲内の点の位置 [m]
+     * @param OutColors           範囲内の点の色 (A = Intensity)
+     * @return                    成功可否
+     */
+    UFUNCTION(BlueprintCallable, Category = "Lidar|Export")
+    static bool ReadCompressedPointsInBox(
+        const FString& AbsoluteFilePath,
+        const FBox&    QueryBox,
+        TArray<FVector>& OutPositions,
+        TArray<FColor>&  OutColors
+    );
+
     /**
      * カメラの視錐台に入っている LidarPointCloudActor を取得
      *
@@ -0,0 +1,577 @@
+#include "PointCloudExportCommandlet.h"
+
+#include "ExportVisibleLidarPointsLOD.h"
+#include "LidarPointCloud.h"
+#include "LidarPointCloudActor.h"
+#include "LidarPointCloudComponent.h"
+#include "Camera/CameraActor.h"
+#include "Camera/CameraComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+#include "UObject/Package.h"
+#include "UObject/UnrealType.h"
+#include "UObject/UObjectGlobals.h"
+
+// ------------------------------------------------------------
+//  ヘルパ: ジョブ文字列の解析
+// ------------------------------------------------------------
+namespace
+{
+    struct FCameraPose
+    {
+        FVector  Location = FVector::ZeroVector;
+        FRotator Rotation = FRotator::ZeroRotator;
+        float    FieldOfView = 90.f;
+        float    AspectRatio = 1.777778f;
+    };
+}
+
+// 相対パスはエンジンのバイナリフォルダではなく、コマンドを起動したディレクトリ基準で解決する
+static FString ResolveLaunchPath(const FString& Path)
+{
+    return FPaths::ConvertRelativePathToFull(FPaths::LaunchDir(), Path);
+}
+
+// "X,Y,Z,Pitch,Yaw,Roll[,FOV[,Aspect]]" (カンマまたは空白区切り) [cm, deg]
+static bool ParsePose(const FString& Text, float DefaultFOV, float DefaultAspect, FCameraPose& OutPose)
+{
+    TArray<FString> Parts;
+    Text.Replace(TEXT(","), TEXT(" ")).ParseIntoArrayWS(Parts);
+    if (Parts.Num() < 6)
+    {
+        return false;
+    }
+    for (const FString& Part : Parts)
+    {
+        if (!Part.IsNumeric())
+        {
+            return false;
+        }
+    }
+    OutPose.Location = FVector(FCString::Atod(*Parts[0]), FCString::Atod(*Parts[1]), FCString::Atod(*Parts[2]));
+    OutPose.Rotation = FRotator(FCString::Atod(*Parts[3]), FCString::Atod(*Parts[4]), FCString::Atod(*Parts[5]));
+    OutPose.FieldOfView = Parts.Num() > 6 ? FCString::Atof(*Parts[6]) : DefaultFOV;
+    OutPose.AspectRatio = Parts.Num() > 7 ? FCString::Atof(*Parts[7]) : DefaultAspect;
+    return true;
+}
+
+// 空行と # 以降のコメントを取り除いた行を返す
+static void ReadJobLines(const FString& Text, TArray<FString>& OutLines)
+{
+    TArray<FString> Lines;
+    Text.ParseIntoArrayLines(Lines);
+    for (FString& Line : Lines)
+    {
+        int32 CommentIndex = INDEX_NONE;
+        if (Line.FindChar(TEXT('#'), CommentIndex))
+        {
+            Line.LeftInline(CommentIndex);
+        }
+        Line.TrimStartAndEndInline();
+        if (!Line.IsEmpty())
+        {
+            OutLines.Add(Line);
+        }
+    }
+}
+
+static TArray<FString> ParseList(const TCHAR* Job, const TCHAR* Key)
+{
+    FString Value;
+    TArray<FString> Items;
+    if (FParse::Value(Job, Key, Value, /*bShouldStopOnSeparator=*/false))
+    {
+        Value.ParseIntoArray(Items, TEXT(","), /*InCullEmpty=*/true);
+        for (FString& Item : Items)
+        {
+            Item.TrimStartAndEndInline();
+        }
+    }
+    return Items;
+}
+
+// "/Game/Foo/Bar" を "/Game/Foo/Bar.Bar" に補完してロード
+static ULidarPointCloud* LoadPointCloudAsset(const FString& AssetPath)
+{
+    FString ObjectPath = AssetPath;
+    if (!ObjectPath.Contains(TEXT(".")))
+    {
+        ObjectPath += TEXT(".") + FPackageName::GetShortName(ObjectPath);
+    }
+    return LoadObject<ULidarPointCloud>(nullptr, *ObjectPath);
+}
+
+static bool MatchesActorName(const AActor* Actor, const FString& Name)
+{
+#if WITH_EDITOR
+    if (Actor->GetActorLabel() == Name)
+    {
+        return true;
+    }
+#endif
+    return Actor->GetName() == Name;
+}
+
+// アクター自身の CameraComponent、無ければ ACameraActor を指すプロパティ経由で取得
+// (BP_Test のように Camera 変数で CineCameraActor を参照する Blueprint 用)
+static UCameraComponent* FindActorCamera(AActor* Actor)
+{
+    if (UCameraComponent* Camera = Actor->FindComponentByClass<UCameraComponent>())
+    {
+        return Camera;
+    }
+    for (TFieldIterator<FObjectProperty> It(Actor->GetClass()); It; ++It)
+    {
+        if (!It->PropertyClass || !It->PropertyClass->IsChildOf(ACameraActor::StaticClass()))
+        {
+            continue;
+        }
+        ACameraActor* CameraActor = Cast<ACameraActor>(It->GetObjectPropertyValue_InContainer(Actor));
+        if (CameraActor && CameraActor->GetCameraComponent())
+        {
+            return CameraActor->GetCameraComponent();
+        }
+    }
+    return nullptr;
+}
+
+// 複数ポーズの場合は {i} を連番に置換 ({i} が無ければ拡張子の前に _0000 を付ける)
+static FString MakeOutputPath(const FString& Template, int32 PoseIndex, int32 PoseCount)
+{
+    const FString Index = FString::Printf(TEXT("%04d"), PoseIndex);
+    FString Path = Template;
+    if (Path.Contains(TEXT("{i}")))
+    {
+        Path.ReplaceInline(TEXT("{i}"), *Index);
+    }
+    else if (PoseCount > 1)
+    {
+        Path = FPaths::GetBaseFilename(Template, /*bRemovePath=*/false) + TEXT("_") + Index
+            + FPaths::GetExtension(Template, /*bIncludeDot=*/true);
+    }
+    return ResolveLaunchPath(Path);
+}
+
+// ------------------------------------------------------------
+//  Commandlet
+// ------------------------------------------------------------
+UPointCloudExportCommandlet::UPointCloudExportCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+    ShowErrorCount = true;
+}
+
+int32 UPointCloudExportCommandlet::Main(const FString& Params)
+{
+    const double BatchStart = FPlatformTime::Seconds();
+
+    TArray<FString> Jobs;
+    FString JobsFile;
+    if (FParse::Value(*Params, TEXT("jobs="), JobsFile))
+    {
+        JobsFile = ResolveLaunchPath(JobsFile);
+        FString Text;
+        if (!FFileHelper::LoadFileToString(Text, *JobsFile))
+        {
+            UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Failed to read job list %s"), *JobsFile);
+            return 1;
+        }
+        ReadJobLines(Text, Jobs);
+    }
+    else
+    {
+        Jobs.Add(Params);
+    }
+
+    if (Jobs.Num() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: No jobs to run."));
+        return 1;
+    }
+
+    TArray<FJobResult> Results;
+    Results.Reserve(Jobs.Num());
+    int32 FailedCount = 0;
+    for (int32 JobIndex = 0; JobIndex < Jobs.Num(); ++JobIndex)
+    {
+        FJobResult& Result = Results.Add_GetRef(RunJob(Jobs[JobIndex]));
+        if (!Result.bSuccess)
+        {
+            ++FailedCount;
+        }
+        UE_LOG(LogTemp, Display,
+            TEXT("PointCloudExportCommandlet: Job %d/%d [%s] %s: %d exports, world %.3f s, export %.3f s"),
+            JobIndex + 1, Jobs.Num(), *Result.Type, Result.bSuccess ? TEXT("OK") : TEXT("FAILED"),
+            Result.ExportCount, Result.WorldSeconds, Result.ExportSeconds);
+    }
+    ReleaseWorld();
+
+    bool bReportFailed = false;
+    FString ReportFile;
+    if (FParse::Value(*Params, TEXT("report="), ReportFile))
+    {
+        ReportFile = ResolveLaunchPath(ReportFile);
+        TArray<FString> Rows;
+        Rows.Add(TEXT("Job,Type,Map,Exports,WorldSeconds,ExportSeconds,Success"));
+        for (int32 i = 0; i < Results.Num(); ++i)
+        {
+            const FJobResult& R = Results[i];
+            Rows.Add(FString::Printf(TEXT("%d,%s,%s,%d,%.6f,%.6f,%d"),
+                i + 1, *R.Type, *R.MapName, R.ExportCount, R.WorldSeconds, R.ExportSeconds, R.bSuccess ? 1 : 0));
+        }
+        if (!FFileHelper::SaveStringArrayToFile(Rows, *ReportFile))
+        {
+            UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Failed to save report %s"), *ReportFile);
+            bReportFailed = true;
+        }
+    }
+
+    UE_LOG(LogTemp, Display,
+        TEXT("PointCloudExportCommandlet: %d/%d jobs succeeded in %.3f s"),
+        Jobs.Num() - FailedCount, Jobs.Num(), FPlatformTime::Seconds() - BatchStart);
+    return (FailedCount == 0 && !bReportFailed) ? 0 : 1;
+}
+
+UPointCloudExportCommandlet::FJobResult UPointCloudExportCommandlet::RunJob(const FString& Job)
+{
+    FJobResult Result;
+    Result.Type = TEXT("Export");
+    FParse::Value(*Job, TEXT("Type="), Result.Type);
+
+    if (Result.Type.Equals(TEXT("Textures"), ESearchCase::IgnoreCase))
+    {
+        const double Start = FPlatformTime::Seconds();
+        const TArray<FString> Assets = ParseList(*Job, TEXT("Asset="));
+        Result.bSuccess = Assets.Num() > 0;
+        for (const FString& AssetPath : Assets)
+        {
+            ULidarPointCloud* Cloud = LoadPointCloudAsset(AssetPath);
+            if (!Cloud)
+            {
+                UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Failed to load point cloud %s"), *AssetPath);
+                Result.bSuccess = false;
+                continue;
+            }
+            if (UExportVisibleLidarPointsLOD::SavePointCloudTextures(Cloud))
+            {
+                ++Result.ExportCount;
+            }
+            else
+            {
+                Result.bSuccess = false;
+            }
+        }
+        Result.ExportSeconds = FPlatformTime::Seconds() - Start;
+        return Result;
+    }
+
+    if (Result.Type.Equals(TEXT("Export"), ESearchCase::IgnoreCase)
+        || Result.Type.Equals(TEXT("Compressed"), ESearchCase::IgnoreCase))
+    {
+        Result.bSuccess = RunExportJob(Job, Result.Type, Result);
+        return Result;
+    }
+
+    UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Unknown job type %s"), *Result.Type);
+    return Result;
+}
+
+bool UPointCloudExportCommandlet::RunExportJob(const FString& Job, const FString& Type, FJobResult& Result)
+{
+    const TCHAR* JobStr = *Job;
+
+    FString OutputTemplate;
+    if (!FParse::Value(JobStr, TEXT("Output="), OutputTemplate))
+    {
+        UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Export job requires Output="));
+        return false;
+    }
+
+    FParse::Value(JobStr, TEXT("Map="), Result.MapName);
+    const TArray<FString> CloudAssets = ParseList(JobStr, TEXT("Clouds="));
+    if (Result.MapName.IsEmpty() && CloudAssets.Num() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Export job requires Map= or Clouds="));
+        return false;
+    }
+
+    // エクスポート設定 (既定値は Blueprint 関数と同じ)
+    float FrustumFar = 10000.f;
+    float NearFullResRadius = 5000.f;
+    float MidSkipRadius = 20000.f;
+    float FarSkipRadius = 100000.f;
+    int32 SkipFactorMid = 2;
+    int32 SkipFactorFar = 10;
+    bool  bWorldSpace = true;
+    int32 MaxPointCount = 20000000;
+    int32 PointsPerBlock = 65536;
+    float QuantizationStep = 0.001f;
+    float DefaultFOV = 90.f;
+    float DefaultAspect = 1.777778f;
+    FParse::Value(JobStr, TEXT("FrustumFar="), FrustumFar);
+    FParse::Value(JobStr, TEXT("NearRadius="), NearFullResRadius);
+    FParse::Value(JobStr, TEXT("MidRadius="), MidSkipRadius);
+    FParse::Value(JobStr, TEXT("FarRadius="), FarSkipRadius);
+    FParse::Value(JobStr, TEXT("SkipMid="), SkipFactorMid);
+    FParse::Value(JobStr, TEXT("SkipFar="), SkipFactorFar);
+    FParse::Bool(JobStr, TEXT("WorldSpace="), bWorldSpace);
+    FParse::Value(JobStr, TEXT("MaxPoints="), MaxPointCount);
+    FParse::Value(JobStr, TEXT("BlockSize="), PointsPerBlock);
+    FParse::Value(JobStr, TEXT("Step="), QuantizationStep);
+    FParse::Value(JobStr, TEXT("FOV="), DefaultFOV);
+    FParse::Value(JobStr, TEXT("Aspect="), DefaultAspect);
+
+    ELidarExportCompression Compression = ELidarExportCompression::Oodle;
+    FString CompressionName;
+    if (FParse::Value(JobStr, TEXT("Compression="), CompressionName))
+    {
+        const int64 Value = StaticEnum<ELidarExportCompression>()->GetValueByNameString(CompressionName);
+        if (Value == INDEX_NONE)
+        {
+            UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Unknown compression %s"), *CompressionName);
+            return false;
+        }
+        Compression = (ELidarExportCompression)Value;
+    }
+
+    UWorld* World = AcquireWorld(Result.MapName, Result.WorldSeconds);
+    if (!World)
+    {
+        return false;
+    }
+
+    const double ExportStart = FPlatformTime::Seconds();
+
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.ObjectFlags |= RF_Transient;
+    TArray<AActor*> SpawnedActors;
+    ON_SCOPE_EXIT
+    {
+        for (AActor* Actor : SpawnedActors)
+        {
+            World->DestroyActor(Actor);
+        }
+        Result.ExportSeconds = FPlatformTime::Seconds() - ExportStart;
+    };
+
+    // Clouds= のアセットは原点に一時アクターとして配置する
+    for (const FString& AssetPath : CloudAssets)
+    {
+        ULidarPointCloud* Cloud = LoadPointCloudAsset(AssetPath);
+        if (!Cloud)
+        {
+            UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Failed to load point cloud %s"), *AssetPath);
+            return false;
+        }
+        ALidarPointCloudActor* CloudActor = World->SpawnActor<ALidarPointCloudActor>(SpawnParams);
+        if (!CloudActor)
+        {
+            UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Failed to spawn actor for point cloud %s"), *AssetPath);
+            return false;
+        }
+        CloudActor->SetPointCloud(Cloud);
+        SpawnedActors.Add(CloudActor);
+    }
+
+    // 対象アクター: Actors= の指定があればその名前のみ、無ければワールド内の全点群
+    const TArray<FString> ActorNames = ParseList(JobStr, TEXT("Actors="));
+    TArray<ALidarPointCloudActor*> PointCloudActors;
+    for (TActorIterator<ALidarPointCloudActor> It(World); It; ++It)
+    {
+        const bool bSpawned = SpawnedActors.Contains(*It);
+        if (ActorNames.Num() == 0 || bSpawned
+            || ActorNames.ContainsByPredicate([&It](const FString& Name) { return MatchesActorName(*It, Name); }))
+        {
+            PointCloudActors.Add(*It);
+        }
+    }
+    if (PointCloudActors.Num() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: No LidarPointCloudActor found for job."));
+        return false;
+    }
+
+    // カメラポーズ: Camera= のアクター、Pose= の値、Poses= のファイルの順に連結
+    TArray<FCameraPose> Poses;
+    for (const FString& CameraName : ParseList(JobStr, TEXT("Camera=")))
+    {
+        AActor* CameraOwner = nullptr;
+        for (TActorIterator<AActor> It(World); It && !CameraOwner; ++It)
+        {
+            if (MatchesActorName(*It, CameraName))
+            {
+                CameraOwner = *It;
+            }
+        }
+        if (!CameraOwner)
+        {
+            UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Camera actor %s not found."), *CameraName);
+            return false;
+        }
+        UCameraComponent* Found = FindActorCamera(CameraOwner);
+        if (!Found)
+        {
+            UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Actor %s has no CameraComponent."), *CameraName);
+            return false;
+        }
+        FCameraPose& Pose = Poses.AddDefaulted_GetRef();
+        Pose.Location = Found->GetComponentLocation();
+        Pose.Rotation = Found->GetComponentRotation();
+        Pose.FieldOfView = Found->FieldOfView;
+        Pose.AspectRatio = Found->AspectRatio;
+    }
+
+    FString PoseText;
+    if (FParse::Value(JobStr, TEXT("Pose="), PoseText, /*bShouldStopOnSeparator=*/false))
+    {
+        if (!ParsePose(PoseText, DefaultFOV, DefaultAspect, Poses.AddDefaulted_GetRef()))
+        {
+            UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Invalid Pose=%s"), *PoseText);
+            return false;
+        }
+    }
+
+    FString PosesFile;
+    if (FParse::Value(JobStr, TEXT("Poses="), PosesFile))
+    {
+        PosesFile = ResolveLaunchPath(PosesFile);
+        FString Text;
+        if (!FFileHelper::LoadFileToString(Text, *PosesFile))
+        {
+            UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Failed to read poses %s"), *PosesFile);
+            return false;
+        }
+        TArray<FString> Lines;
+        ReadJobLines(Text, Lines);
+        for (const FString& Line : Lines)
+        {
+            if (!ParsePose(Line, DefaultFOV, DefaultAspect, Poses.AddDefaulted_GetRef()))
+            {
+                UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Invalid pose \"%s\" in %s"), *Line, *PosesFile);
+                return false;
+            }
+        }
+    }
+
+    if (Poses.Num() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Export job requires Camera=, Pose= or Poses="));
+        return false;
+    }
+
+    ACameraActor* CameraActor = World->SpawnActor<ACameraActor>(SpawnParams);
+    UCameraComponent* Camera = CameraActor ? CameraActor->GetCameraComponent() : nullptr;
+    if (!Camera)
+    {
+        UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Failed to spawn export camera."));
+        return false;
+    }
+    SpawnedActors.Add(CameraActor);
+
+    const bool bCompressed = Type.Equals(TEXT("Compressed"), ESearchCase::IgnoreCase);
+    bool bSuccess = true;
+    for (int32 PoseIndex = 0; PoseIndex < Poses.Num(); ++PoseIndex)
+    {
+        const FCameraPose& Pose = Poses[PoseIndex];
+        Camera->SetWorldLocationAndRotation(Pose.Location, Pose.Rotation);
+        Camera->SetFieldOfView(Pose.FieldOfView);
+        Camera->SetAspectRatio(Pose.AspectRatio);
+
+        const FString OutputPath = MakeOutputPath(OutputTemplate, PoseIndex, Poses.Num());
+        const double PoseStart = FPlatformTime::Seconds();
+        const bool bExported = bCompressed
+            ? UExportVisibleLidarPointsLOD::ExportVisiblePointsCompressed(
+                PointCloudActors, Camera, OutputPath, Compression, PointsPerBlock, QuantizationStep,
+                FrustumFar, NearFullResRadius, MidSkipRadius, FarSkipRadius,
+                SkipFactorMid, SkipFactorFar, bWorldSpace, MaxPointCount)
+            : UExportVisibleLidarPointsLOD::ExportVisiblePointsLOD(
+                PointCloudActors, Camera, OutputPath,
+                FrustumFar, NearFullResRadius, MidSkipRadius, FarSkipRadius,
+                SkipFactorMid, SkipFactorFar, bWorldSpace, /*bExportTexture=*/false, MaxPointCount);
+
+        UE_LOG(LogTemp, Display, TEXT("PointCloudExportCommandlet:   pose %d/%d %s %.3f s → %s"),
+            PoseIndex + 1, Poses.Num(), bExported ? TEXT("OK") : TEXT("FAILED"),
+            FPlatformTime::Seconds() - PoseStart, *OutputPath);
+        if (bExported)
+        {
+            ++Result.ExportCount;
+        }
+        bSuccess &= bExported;
+    }
+    return bSuccess;
+}
+
+// ------------------------------------------------------------
+//  ワールドの読み込み / 破棄 (同じ Map が続く限り使い回す)
+// ------------------------------------------------------------
+UWorld* UPointCloudExportCommandlet::AcquireWorld(const FString& MapName, double& OutSeconds)
+{
+    if (CurrentWorld && CurrentMapName == MapName)
+    {
+        return CurrentWorld;
+    }
+
+    ReleaseWorld();
+    const double Start = FPlatformTime::Seconds();
+
+    if (MapName.IsEmpty())
+    {
+        // Clouds= のみのジョブ用の空ワールド
+        CurrentWorld = UWorld::CreateWorld(EWorldType::Editor, /*bInformEngineOfWorld=*/false, TEXT("PointCloudExportTransient"));
+    }
+    else
+    {
+        UPackage* Package = LoadPackage(nullptr, *MapName, LOAD_None);
+        UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+        if (!World)
+        {
+            UE_LOG(LogTemp, Error, TEXT("PointCloudExportCommandlet: Failed to load map %s"), *MapName);
+            return nullptr;
+        }
+
+        World->WorldType = EWorldType::Editor;
+        World->AddToRoot();
+        if (!World->bIsWorldInitialized)
+        {
+            World->InitWorld(UWorld::InitializationValues()
+                .ShouldSimulatePhysics(false)
+                .EnableTraceCollision(false)
+                .CreateNavigation(false)
+                .CreateAISystem(false)
+                .AllowAudioPlayback(false)
+                .RequiresHitProxies(false));
+        }
+        World->UpdateWorldComponents(/*bRerunConstructionScripts=*/true, /*bCurrentLevelOnly=*/false);
+        CurrentWorld = World;
+    }
+
+    CurrentMapName = MapName;
+    OutSeconds = FPlatformTime::Seconds() - Start;
+    UE_LOG(LogTemp, Display, TEXT("PointCloudExportCommandlet: Loaded world %s in %.3f s"),
+        MapName.IsEmpty() ? TEXT("(transient)") : *MapName, OutSeconds);
+    return CurrentWorld;
+}
+
+void UPointCloudExportCommandlet::ReleaseWorld()
+{
+    if (!CurrentWorld)
+    {
+        return;
+    }
+
+    // ロードした Map も CreateWorld で作ったワールドもルートに追加済み
+    CurrentWorld->DestroyWorld(/*bInformEngineOfWorld=*/false);
+    CurrentWorld->RemoveFromRoot();
+    CurrentWorld = nullptr;
+    CurrentMapName.Reset();
+    CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PointCloudExportCommandlet.generated.h"
+
+class UWorld;
+
+/**
+ * ExportVisiblePointsLOD / ExportVisiblePointsCompressed / SavePointCloudTextures を
+ * エディタ UI なしでバッチ実行する Commandlet
+ *
+ * 実行例:
+ *   UnrealEditor-Cmd PointCloudExport.uproject -run=PointCloudExport
+ *       -jobs=/data/jobs.txt -report=/data/timing.csv -nullrhi -unattended
+ *
+ * ジョブファイルは 1 行 1 ジョブ (Key=Value をスペース区切り、# 以降はコメント)。
+ * -jobs を省略した場合はコマンドライン自体を 1 ジョブとして扱う。
+ * 書式は docs/example_jobs.txt を参照。
+ * 同じ Map を続けて使うジョブはロード済みのワールドを再利用する。
+ */
+UCLASS()
+class POINTCLOUDEXPORT_API UPointCloudExportCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UPointCloudExportCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+
+private:
+    /** ジョブ 1 件分の計測結果 */
+    struct FJobResult
+    {
+        FString Type;
+        FString MapName;
+        int32   ExportCount = 0;
+        double  WorldSeconds = 0.0;
+        double  ExportSeconds = 0.0;
+        bool    bSuccess = false;
+    };
+
+    FJobResult RunJob(const FString& Job);
+    bool RunExportJob(const FString& Job, const FString& Type, FJobResult& Result);
+
+    /** Map のワールドを取得 (直前と同じ Map ならロード済みのものを返す。空なら一時ワールド) */
+    UWorld* AcquireWorld(const FString& MapName, double& OutSeconds);
+    void ReleaseWorld();
+
+    UPROPERTY(Transient)
+    TObjectPtr<UWorld> CurrentWorld;
+
+    FString CurrentMapName;
+};